@@ -0,0 +1,287 @@
+/*
+ * batch-loader.hpp         -- lazy evaluating variables loaded in batches
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BATCH_LOADER_HPP_2026_10_18__
+#define __BATCH_LOADER_HPP_2026_10_18__
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "lazy.hpp"
+
+namespace NReinventedWheels
+{
+    namespace NPrivate
+    {
+        // keys registered in a single batch window and values loaded for
+        // them, shared by calculators of all lazy values of the batch
+        template <class TKey, class TValue>
+        class TBatch
+        {
+            typedef std::function<std::vector<TValue>(
+                const std::vector<TKey>&)> TLoader;
+
+            const std::shared_ptr<const TLoader> Loader_;
+            // guards keys registration and values handout, loader is never
+            // called under it, so lazy values of the next batch can be
+            // created during load
+            std::mutex Lock_;
+            bool Closed_;
+            std::vector<TKey> Keys_;
+            // number of calculators referring to each key, keys without
+            // them are not loaded
+            std::vector<size_t> Refs_;
+            // index of loaded value for each key
+            std::vector<size_t> Positions_;
+            std::vector<TValue> Values_;
+            // serializes loader calls
+            std::mutex LoadLock_;
+            std::atomic<bool> Loaded_;
+
+            inline void Load()
+            {
+                std::lock_guard<std::mutex> loadGuard(LoadLock_);
+                if (Loaded_.load(std::memory_order_relaxed))
+                {
+                    return;
+                }
+                std::vector<TKey> keys;
+                std::vector<size_t> positions;
+                {
+                    std::lock_guard<std::mutex> guard(Lock_);
+                    Closed_ = true;
+                    positions.resize(Keys_.size(), 0);
+                    for (size_t i = 0; i < Keys_.size(); ++i)
+                    {
+                        if (Refs_[i])
+                        {
+                            positions[i] = keys.size();
+                            keys.push_back(Keys_[i]);
+                        }
+                    }
+                }
+                std::vector<TValue> values;
+                if (!keys.empty())
+                {
+                    values = (*Loader_)(keys);
+                }
+                if (values.size() != keys.size())
+                {
+                    throw std::length_error(
+                        "Batch loader returned wrong number of values");
+                }
+                std::lock_guard<std::mutex> guard(Lock_);
+                Positions_.swap(positions);
+                Values_.swap(values);
+                Keys_ = std::vector<TKey>();
+                Loaded_.store(true, std::memory_order_release);
+            }
+
+        public:
+            inline explicit TBatch(
+                const std::shared_ptr<const TLoader>& loader)
+                : Loader_(loader)
+                , Closed_(false)
+                , Loaded_(false)
+            {
+            }
+
+            // returns false if batch is closed already and can't accept new
+            // keys, otherwise registers key with one calculator referring
+            // to it
+            inline bool Add(const TKey& key, size_t& index)
+            {
+                std::lock_guard<std::mutex> guard(Lock_);
+                if (Closed_)
+                {
+                    return false;
+                }
+                index = Keys_.size();
+                Keys_.push_back(key);
+                Refs_.push_back(1);
+                return true;
+            }
+
+            inline void Acquire(size_t index)
+            {
+                std::lock_guard<std::mutex> guard(Lock_);
+                ++Refs_[index];
+            }
+
+            inline void Release(size_t index)
+            {
+                std::lock_guard<std::mutex> guard(Lock_);
+                --Refs_[index];
+            }
+
+            inline void Close()
+            {
+                if (!Loaded_.load(std::memory_order_acquire))
+                {
+                    Load();
+                }
+            }
+
+            // returns value and releases calculator reference, value is
+            // moved out for the last calculator referring to key
+            inline TValue Take(size_t index)
+            {
+                Close();
+                std::lock_guard<std::mutex> guard(Lock_);
+                TValue& value = Values_[Positions_[index]];
+                if (Refs_[index] == 1)
+                {
+                    TValue result(std::move(value));
+                    Refs_[index] = 0;
+                    return result;
+                }
+                TValue result(value);
+                --Refs_[index];
+                return result;
+            }
+        };
+
+        // calculator of lazy value of a batch, keeps key of batch alive
+        // until value is calculated or calculator is destroyed
+        template <class TKey, class TValue>
+        class TBatchValue
+        {
+            typedef TBatch<TKey, TValue> TBatchType;
+
+            // released after calculation, so calculated values don't hold
+            // batch
+            mutable std::shared_ptr<TBatchType> Batch_;
+            size_t Index_;
+
+            TBatchValue& operator = (const TBatchValue&) = delete;
+
+        public:
+            // batch should have reference for index acquired already
+            inline TBatchValue(std::shared_ptr<TBatchType> batch,
+                size_t index)
+                : Batch_(std::move(batch))
+                , Index_(index)
+            {
+            }
+
+            inline TBatchValue(const TBatchValue& value)
+                : Batch_(value.Batch_)
+                , Index_(value.Index_)
+            {
+                if (Batch_)
+                {
+                    Batch_->Acquire(Index_);
+                }
+            }
+
+            inline TBatchValue(TBatchValue&& value)
+                : Batch_(std::move(value.Batch_))
+                , Index_(value.Index_)
+            {
+            }
+
+            inline ~TBatchValue()
+            {
+                if (Batch_)
+                {
+                    Batch_->Release(Index_);
+                }
+            }
+
+            inline TValue operator () () const
+            {
+                TValue value(Batch_->Take(Index_));
+                Batch_.reset();
+                return value;
+            }
+        };
+    }
+
+    // Creates lazy values, which are loaded together. Each lazy value
+    // registers its key in current batch window, and when any of them is
+    // accessed first time, keys of the window, which lazy values are still
+    // alive and not assigned, are passed to a single loader call, so the
+    // rest of lazy values of the batch will be calculated without loader
+    // calls. Batch window is closed on load and lazy values created after
+    // that will be loaded in the next batch.
+    // Loader should return values in the same order as keys passed.
+    template <class TKey, class TValue>
+    class TBatchLoader
+    {
+    public:
+        typedef std::function<std::vector<TValue>(const std::vector<TKey>&)>
+            TLoader;
+
+    private:
+        typedef NPrivate::TBatch<TKey, TValue> TBatch;
+
+        const std::shared_ptr<const TLoader> Loader_;
+        std::mutex Lock_;
+        std::shared_ptr<TBatch> Batch_;
+
+    public:
+        inline explicit TBatchLoader(const TLoader& loader)
+            : Loader_(std::make_shared<const TLoader>(loader))
+        {
+        }
+
+        inline explicit TBatchLoader(TLoader&& loader)
+            : Loader_(std::make_shared<const TLoader>(std::move(loader)))
+        {
+        }
+
+        // lazy values can outlive the loader
+        inline TLazy<TValue> Lazy(const TKey& key)
+        {
+            std::lock_guard<std::mutex> guard(Lock_);
+            size_t index = 0;
+            if (!Batch_ || !Batch_->Add(key, index))
+            {
+                Batch_ = std::make_shared<TBatch>(Loader_);
+                Batch_->Add(key, index);
+            }
+            return TLazy<TValue>(
+                NPrivate::TBatchValue<TKey, TValue>(Batch_, index));
+        }
+
+        // loads current batch window, even if no lazy values of it were
+        // accessed yet
+        inline void Flush()
+        {
+            std::shared_ptr<TBatch> batch;
+            {
+                std::lock_guard<std::mutex> guard(Lock_);
+                batch.swap(Batch_);
+            }
+            if (batch)
+            {
+                batch->Close();
+            }
+        }
+    };
+}
+
+#endif
+
@@ -0,0 +1,127 @@
+/*
+ * batch-loader.cpp         -- lazy evaluating variables loaded in batches
+ *                             benchmark
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <batch-loader.hpp>
+using NReinventedWheels::TBatchLoader;
+using NReinventedWheels::TLazy;
+
+typedef std::chrono::steady_clock TClock;
+
+void Spin(std::chrono::nanoseconds duration)
+{
+    TClock::time_point deadline = TClock::now() + duration;
+    while (TClock::now() < deadline)
+    {
+    }
+}
+
+// simulated storage, which charges fixed cost per call and small cost per
+// key loaded
+class TBackend
+{
+    const std::chrono::nanoseconds CallCost_;
+    const std::chrono::nanoseconds KeyCost_;
+    int Calls_;
+
+public:
+    inline TBackend(int callMicros, int keyNanos)
+        : CallCost_(std::chrono::microseconds(callMicros))
+        , KeyCost_(keyNanos)
+        , Calls_(0)
+    {
+    }
+
+    inline std::vector<int> Load(const std::vector<int>& keys)
+    {
+        ++Calls_;
+        Spin(CallCost_ + KeyCost_ * keys.size());
+        return keys;
+    }
+
+    inline int Calls() const
+    {
+        return Calls_;
+    }
+};
+
+// accesses every step'th lazy value and returns elapsed milliseconds
+double Access(std::vector<TLazy<int>>& lazies, int step)
+{
+    TClock::time_point start = TClock::now();
+    long long sum = 0;
+    for (size_t i = 0; i < lazies.size(); i += step)
+    {
+        sum += lazies[i];
+    }
+    if (sum < 0)
+    {
+        std::abort();
+    }
+    return std::chrono::duration<double, std::milli>(
+        TClock::now() - start).count();
+}
+
+void Measure(int size, int step, int callMicros, int keyNanos)
+{
+    TBackend single(callMicros, keyNanos);
+    std::vector<TLazy<int>> lazies;
+    for (int i = 0; i < size; ++i)
+    {
+        lazies.emplace_back(
+            [&single, i](){ return single.Load(std::vector<int>(1, i))[0]; });
+    }
+    double singleTime = Access(lazies, step);
+
+    TBackend batch(callMicros, keyNanos);
+    TBatchLoader<int, int> loader(
+        [&batch](const std::vector<int>& keys){ return batch.Load(keys); });
+    lazies.clear();
+    for (int i = 0; i < size; ++i)
+    {
+        lazies.push_back(loader.Lazy(i));
+    }
+    double batchTime = Access(lazies, step);
+
+    std::printf("%8d %8d %12.2f %8d %12.2f %8d\n", size / step, size,
+        singleTime, single.Calls(), batchTime, batch.Calls());
+}
+
+int main(int argc, char* argv[])
+{
+    int size = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int callMicros = argc > 2 ? std::atoi(argv[2]) : 20;
+    int keyNanos = argc > 3 ? std::atoi(argv[3]) : 100;
+
+    std::printf("backend charges %d us per call and %d ns per key\n",
+        callMicros, keyNanos);
+    std::printf("%8s %8s %12s %8s %12s %8s\n", "accessed", "lazies",
+        "single, ms", "calls", "batch, ms", "calls");
+    for (int step = 1; step <= 100; step *= 10)
+    {
+        Measure(size, step, callMicros, keyNanos);
+    }
+    return 0;
+}
+
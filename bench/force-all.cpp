@@ -0,0 +1,104 @@
+/*
+ * force-all.cpp            -- lazy values ranges evaluation benchmark
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <force-all.hpp>
+using NReinventedWheels::ForceAll;
+using NReinventedWheels::TLazy;
+namespace NExecution = NReinventedWheels::NExecution;
+
+typedef std::chrono::steady_clock TClock;
+
+// burns cpu for specified amount of microseconds, sleeping won't do here as
+// it doesn't load cores
+int Spin(int micros)
+{
+    TClock::time_point deadline =
+        TClock::now() + std::chrono::microseconds(micros);
+    int result = 0;
+    while (TClock::now() < deadline)
+    {
+        ++result;
+    }
+    return result;
+}
+
+std::vector<TLazy<int>> MakeUniform(int size, int micros)
+{
+    std::vector<TLazy<int>> lazies;
+    for (int i = 0; i < size; ++i)
+    {
+        lazies.emplace_back([micros](){ return Spin(micros); });
+    }
+    return lazies;
+}
+
+// elements of the first sixteenth of the range are hundred times more
+// expensive than the rest, so static partitioning will load the first worker
+// only
+std::vector<TLazy<int>> MakeSkewed(int size, int micros)
+{
+    std::vector<TLazy<int>> lazies;
+    for (int i = 0; i < size; ++i)
+    {
+        int cost = i < size / 16 ? micros * 100 : micros;
+        lazies.emplace_back([cost](){ return Spin(cost); });
+    }
+    return lazies;
+}
+
+double Measure(std::vector<TLazy<int>> lazies, size_t threads)
+{
+    TClock::time_point start = TClock::now();
+    ForceAll(lazies.begin(), lazies.end(), NExecution::Par, threads);
+    return std::chrono::duration<double, std::milli>(
+        TClock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int size = argc > 1 ? std::atoi(argv[1]) : 10000;
+    int micros = argc > 2 ? std::atoi(argv[2]) : 10;
+    size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::printf("%d lazy values, %d us per calculator\n", size, micros);
+    std::printf("%8s %14s %8s %14s %8s\n",
+        "threads", "uniform, ms", "speedup", "skewed, ms", "speedup");
+    double uniformBase = 0, skewedBase = 0;
+    for (size_t threads = 1; threads <= cores; ++threads)
+    {
+        double uniform = Measure(MakeUniform(size, micros), threads);
+        double skewed = Measure(MakeSkewed(size, micros), threads);
+        if (threads == 1)
+        {
+            uniformBase = uniform;
+            skewedBase = skewed;
+        }
+        std::printf("%8zu %14.2f %8.2f %14.2f %8.2f\n", threads,
+            uniform, uniformBase / uniform, skewed, skewedBase / skewed);
+    }
+    return 0;
+}
+
@@ -0,0 +1,178 @@
+/*
+ * lazy-decoded.cpp         -- lazy decoded fields over shared byte buffers
+ *                             benchmark
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <lazy-decoded.hpp>
+using NReinventedWheels::TBufferSlice;
+using NReinventedWheels::TLazyDecoded;
+using NReinventedWheels::TPodCodec;
+using NReinventedWheels::TStringCodec;
+
+typedef std::chrono::steady_clock TClock;
+
+// each message consists of Fields numbers followed by Fields strings, every
+// field is prefixed with its 32-bit length
+const int Fields = 8;
+const size_t StringSize = 64;
+
+void Append(std::string& buffer, const void* data, uint32_t size)
+{
+    buffer.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    buffer.append(reinterpret_cast<const char*>(data), size);
+}
+
+std::shared_ptr<const std::string> MakeStream(int messages)
+{
+    std::string buffer;
+    for (int i = 0; i < messages; ++i)
+    {
+        for (int j = 0; j < Fields; ++j)
+        {
+            int64_t number = i * Fields + j;
+            Append(buffer, &number, sizeof(number));
+        }
+        for (int j = 0; j < Fields; ++j)
+        {
+            std::string text(StringSize, 'a' + j);
+            Append(buffer, text.data(), text.size());
+        }
+    }
+    return std::make_shared<const std::string>(std::move(buffer));
+}
+
+uint32_t ReadSize(const char* data)
+{
+    uint32_t size;
+    std::memcpy(&size, data, sizeof(size));
+    return size;
+}
+
+struct TEagerMessage
+{
+    std::vector<int64_t> Numbers_;
+    std::vector<std::string> Strings_;
+
+    inline explicit TEagerMessage(const char*& data)
+    {
+        for (int i = 0; i < Fields; ++i)
+        {
+            uint32_t size = ReadSize(data);
+            data += sizeof(size);
+            Numbers_.push_back(TPodCodec<int64_t>::Decode(
+                std::string_view(data, size)));
+            data += size;
+        }
+        for (int i = 0; i < Fields; ++i)
+        {
+            uint32_t size = ReadSize(data);
+            data += sizeof(size);
+            Strings_.push_back(std::string(data, size));
+            data += size;
+        }
+    }
+};
+
+struct TLazyMessage
+{
+    std::vector<TLazyDecoded<int64_t, TPodCodec<int64_t>>> Numbers_;
+    std::vector<TLazyDecoded<std::string, TStringCodec>> Strings_;
+
+    inline TLazyMessage(const TBufferSlice& buffer, size_t& offset)
+    {
+        Numbers_.reserve(Fields);
+        Strings_.reserve(Fields);
+        for (int i = 0; i < Fields; ++i)
+        {
+            uint32_t size = ReadSize(buffer.Data() + offset);
+            offset += sizeof(size);
+            Numbers_.emplace_back(buffer.Slice(offset, size));
+            offset += size;
+        }
+        for (int i = 0; i < Fields; ++i)
+        {
+            uint32_t size = ReadSize(buffer.Data() + offset);
+            offset += sizeof(size);
+            Strings_.emplace_back(buffer.Slice(offset, size));
+            offset += size;
+        }
+    }
+};
+
+// reads one number and one string of each message, copying messages before
+// if requested, as pipeline stages usually do, returns elapsed milliseconds
+template <class TMessage, class TParser>
+double Measure(int messages, bool copy, TParser parser)
+{
+    TClock::time_point start = TClock::now();
+    std::vector<TMessage> stream;
+    stream.reserve(messages);
+    for (int i = 0; i < messages; ++i)
+    {
+        stream.push_back(parser());
+    }
+    if (copy)
+    {
+        std::vector<TMessage> copies(stream);
+        stream.swap(copies);
+    }
+    size_t sum = 0;
+    for (const TMessage& message: stream)
+    {
+        sum += static_cast<const int64_t&>(message.Numbers_[1]);
+        sum += static_cast<const std::string&>(message.Strings_[2]).size();
+    }
+    if (sum == 0)
+    {
+        std::abort();
+    }
+    return std::chrono::duration<double, std::milli>(
+        TClock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    int messages = argc > 1 ? std::atoi(argv[1]) : 100000;
+    std::shared_ptr<const std::string> buffer(MakeStream(messages));
+
+    std::printf("%d messages of %d fields, 2 fields accessed\n", messages,
+        Fields * 2);
+    std::printf("%8s %12s %12s\n", "copied", "eager, ms", "lazy, ms");
+    for (int copy = 0; copy < 2; ++copy)
+    {
+        const char* data = buffer->data();
+        double eager = Measure<TEagerMessage>(messages, copy,
+            [&data](){ return TEagerMessage(data); });
+        TBufferSlice slice(buffer);
+        size_t offset = 0;
+        double lazy = Measure<TLazyMessage>(messages, copy,
+            [&slice, &offset](){ return TLazyMessage(slice, offset); });
+        std::printf("%8s %12.2f %12.2f\n", copy ? "yes" : "no", eager, lazy);
+    }
+    return 0;
+}
+
@@ -0,0 +1,142 @@
+/*
+ * snapshot-lazy.cpp        -- lazy evaluating variables with lock-free
+ *                             publication of new versions benchmark
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <snapshot-lazy.hpp>
+using NReinventedWheels::TSnapshot;
+using NReinventedWheels::TSnapshotLazy;
+
+typedef std::vector<int> TConfig;
+
+// baseline: readers copy shared pointer under mutex
+class TLockedConfig
+{
+    mutable std::mutex Lock_;
+    std::shared_ptr<const TConfig> Config_;
+
+public:
+    inline TLockedConfig()
+        : Config_(std::make_shared<TConfig>(16, 0))
+    {
+    }
+
+    inline std::shared_ptr<const TConfig> Get() const
+    {
+        std::lock_guard<std::mutex> guard(Lock_);
+        return Config_;
+    }
+
+    inline void Set(int value)
+    {
+        std::shared_ptr<const TConfig> config =
+            std::make_shared<TConfig>(16, value);
+        std::lock_guard<std::mutex> guard(Lock_);
+        Config_.swap(config);
+    }
+};
+
+class TSnapshotConfig
+{
+    TSnapshotLazy<TConfig> Config_;
+
+public:
+    inline TSnapshotConfig()
+        : Config_([](){ return TConfig(16, 0); })
+    {
+    }
+
+    inline TSnapshot<TConfig> Get() const
+    {
+        return Config_.Snapshot();
+    }
+
+    inline void Set(int value)
+    {
+        Config_.Publish([value](){ return TConfig(16, value); });
+    }
+};
+
+// runs readers for specified amount of milliseconds, while writer publishes
+// new version every 100 microseconds, returns millions of reads per second
+template <class TConfigHolder>
+double Measure(size_t readers, int millis)
+{
+    TConfigHolder holder;
+    std::atomic<bool> stop(false);
+    std::atomic<long long> reads(0);
+    std::atomic<long long> checksum(0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < readers; ++i)
+    {
+        threads.emplace_back([&holder, &stop, &reads, &checksum]()
+            {
+                long long count = 0, sum = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    sum += (*holder.Get())[count & 15];
+                    ++count;
+                }
+                reads += count;
+                checksum += sum;
+            });
+    }
+    threads.emplace_back([&holder, &stop]()
+        {
+            for (int i = 1; !stop.load(std::memory_order_relaxed); ++i)
+            {
+                holder.Set(i);
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+    stop.store(true);
+    for (std::thread& thread: threads)
+    {
+        thread.join();
+    }
+    return reads.load() / (millis * 1000.0);
+}
+
+int main(int argc, char* argv[])
+{
+    int millis = argc > 1 ? std::atoi(argv[1]) : 1000;
+    size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::printf("reads per microsecond during %d ms with concurrent writer\n",
+        millis);
+    std::printf("%8s %14s %14s\n", "readers", "snapshot", "mutex");
+    for (size_t readers = 1; readers <= cores; ++readers)
+    {
+        std::printf("%8zu %14.2f %14.2f\n", readers,
+            Measure<TSnapshotConfig>(readers, millis),
+            Measure<TLockedConfig>(readers, millis));
+    }
+    return 0;
+}
+
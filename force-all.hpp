@@ -0,0 +1,312 @@
+/*
+ * force-all.hpp            -- evaluation of lazy values ranges
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FORCE_ALL_HPP_2026_10_18__
+#define __FORCE_ALL_HPP_2026_10_18__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "lazy.hpp"
+
+namespace NReinventedWheels
+{
+    // execution policies mirroring std::execution ones, which can't be used
+    // here without linking parallel algorithms backend
+    struct TSequencedPolicy
+    {
+    };
+
+    struct TParallelPolicy
+    {
+    };
+
+    struct TParallelUnsequencedPolicy
+    {
+    };
+
+    namespace NExecution
+    {
+        constexpr TSequencedPolicy Seq = TSequencedPolicy();
+        constexpr TParallelPolicy Par = TParallelPolicy();
+        constexpr TParallelUnsequencedPolicy ParUnseq =
+            TParallelUnsequencedPolicy();
+    }
+
+    namespace NPrivate
+    {
+        template <class TValue, class TCalculator>
+        inline const TLazy<TValue, TCalculator>* GetLazy(
+            const TLazy<TValue, TCalculator>& lazy)
+        {
+            return &lazy;
+        }
+
+        // allows to force std::map and std::unordered_map values
+        template <class TKey, class TValue, class TCalculator>
+        inline const TLazy<TValue, TCalculator>* GetLazy(
+            const std::pair<TKey, TLazy<TValue, TCalculator>>& item)
+        {
+            return &item.second;
+        }
+
+        template <class TValue, class TCalculator>
+        inline void Force(const TLazy<TValue, TCalculator>* lazy)
+        {
+            static_cast<void>(static_cast<const TValue&>(*lazy));
+        }
+
+        // range of pending lazy values owned by a single worker, the owner
+        // pops chunks from the front, idle workers steal half of the rest
+        // from the back
+        class TForceQueue
+        {
+            std::mutex Lock_;
+            size_t Begin_;
+            size_t End_;
+
+        public:
+            inline TForceQueue()
+                : Begin_(0)
+                , End_(0)
+            {
+            }
+
+            inline void Reset(size_t begin, size_t end)
+            {
+                std::lock_guard<std::mutex> guard(Lock_);
+                Begin_ = begin;
+                End_ = end;
+            }
+
+            inline bool Pop(size_t chunk, size_t& begin, size_t& end)
+            {
+                std::lock_guard<std::mutex> guard(Lock_);
+                if (Begin_ == End_)
+                {
+                    return false;
+                }
+                begin = Begin_;
+                end = Begin_ + std::min(chunk, End_ - Begin_);
+                Begin_ = end;
+                return true;
+            }
+
+            inline bool Steal(size_t& begin, size_t& end)
+            {
+                std::lock_guard<std::mutex> guard(Lock_);
+                if (Begin_ == End_)
+                {
+                    return false;
+                }
+                begin = End_ - (End_ - Begin_ + 1) / 2;
+                end = End_;
+                End_ = begin;
+                return true;
+            }
+        };
+
+        template <class TLazyPtr>
+        class TForceScheduler
+        {
+            const std::vector<TLazyPtr>& Pending_;
+            const size_t Chunk_;
+            std::unique_ptr<TForceQueue[]> Queues_;
+            const size_t Workers_;
+            std::atomic<bool> Failed_;
+            std::mutex ExceptionLock_;
+            std::exception_ptr Exception_;
+
+            inline bool Steal(size_t worker, size_t& begin, size_t& end)
+            {
+                for (size_t i = 1; i < Workers_; ++i)
+                {
+                    if (Queues_[(worker + i) % Workers_].Steal(begin, end))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        public:
+            inline TForceScheduler(const std::vector<TLazyPtr>& pending,
+                size_t workers)
+                : Pending_(pending)
+                , Chunk_(std::max<size_t>(1, pending.size() / (workers * 32)))
+                , Queues_(new TForceQueue[workers])
+                , Workers_(workers)
+                , Failed_(false)
+            {
+                for (size_t i = 0; i < Workers_; ++i)
+                {
+                    Queues_[i].Reset(Pending_.size() * i / Workers_,
+                        Pending_.size() * (i + 1) / Workers_);
+                }
+            }
+
+            inline void Run(size_t worker)
+            {
+                TForceQueue& queue = Queues_[worker];
+                size_t begin, end;
+                try
+                {
+                    while (!Failed_.load(std::memory_order_relaxed))
+                    {
+                        if (queue.Pop(Chunk_, begin, end))
+                        {
+                            for (; begin != end; ++begin)
+                            {
+                                Force(Pending_[begin]);
+                            }
+                        }
+                        else if (Steal(worker, begin, end))
+                        {
+                            queue.Reset(begin, end);
+                        }
+                        else
+                        {
+                            break;
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(ExceptionLock_);
+                    if (!Exception_)
+                    {
+                        Exception_ = std::current_exception();
+                    }
+                    Failed_.store(true, std::memory_order_relaxed);
+                }
+            }
+
+            inline void Rethrow() const
+            {
+                if (Exception_)
+                {
+                    std::rethrow_exception(Exception_);
+                }
+            }
+        };
+
+        template <class TIterator>
+        inline void ForceAllParallel(TIterator first, TIterator last,
+            size_t threads)
+        {
+            typedef decltype(GetLazy(*first)) TLazyPtr;
+            std::vector<TLazyPtr> pending;
+            for (; first != last; ++first)
+            {
+                TLazyPtr lazy = GetLazy(*first);
+                if (!lazy->IsInitialized())
+                {
+                    pending.push_back(lazy);
+                }
+            }
+
+            threads = std::min(std::max<size_t>(threads, 1), pending.size());
+            if (threads <= 1)
+            {
+                for (TLazyPtr lazy: pending)
+                {
+                    Force(lazy);
+                }
+                return;
+            }
+
+            TForceScheduler<TLazyPtr> scheduler(pending, threads);
+            std::vector<std::thread> workers;
+            workers.reserve(threads - 1);
+            try
+            {
+                for (size_t i = 1; i < threads; ++i)
+                {
+                    workers.emplace_back(&TForceScheduler<TLazyPtr>::Run,
+                        &scheduler, i);
+                }
+            }
+            catch (const std::system_error&)
+            {
+                // queues of workers failed to start will be stolen by others
+            }
+            scheduler.Run(0);
+            for (std::thread& worker: workers)
+            {
+                worker.join();
+            }
+            scheduler.Rethrow();
+        }
+
+        inline size_t DefaultThreads()
+        {
+            return std::max(std::thread::hardware_concurrency(), 1u);
+        }
+    }
+
+    // Calculates values of all lazy values in range [first, last) which are
+    // not initialized yet. Range elements should be either TLazy or pairs
+    // with TLazy as a second member. Already initialized values are skipped
+    // without touching their calculators.
+    // For parallel policies calculators run concurrently, so they shouldn't
+    // refer to other lazy values from the same range. If some calculators
+    // throw, the first exception caught is rethrown after all workers stop.
+    template <class TIterator>
+    inline void ForceAll(TIterator first, TIterator last,
+        const TSequencedPolicy&)
+    {
+        for (; first != last; ++first)
+        {
+            auto lazy = NPrivate::GetLazy(*first);
+            if (!lazy->IsInitialized())
+            {
+                NPrivate::Force(lazy);
+            }
+        }
+    }
+
+    template <class TIterator>
+    inline void ForceAll(TIterator first, TIterator last,
+        const TParallelPolicy&,
+        size_t threads = NPrivate::DefaultThreads())
+    {
+        NPrivate::ForceAllParallel(first, last, threads);
+    }
+
+    // calculators are opaque calls, so there is nothing to vectorize and
+    // unsequenced execution falls back to parallel one
+    template <class TIterator>
+    inline void ForceAll(TIterator first, TIterator last,
+        const TParallelUnsequencedPolicy&,
+        size_t threads = NPrivate::DefaultThreads())
+    {
+        NPrivate::ForceAllParallel(first, last, threads);
+    }
+}
+
+#endif
+
@@ -0,0 +1,151 @@
+/*
+ * lazy-decoded.hpp         -- lazy decoded fields over shared byte buffers
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LAZY_DECODED_HPP_2026_10_18__
+#define __LAZY_DECODED_HPP_2026_10_18__
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "lazy.hpp"
+
+namespace NReinventedWheels
+{
+    // Reference counted slice of shared byte buffer. Copying slice never
+    // copies bytes, buffer is destroyed with the last slice referring to it.
+    class TBufferSlice
+    {
+        std::shared_ptr<const char> Data_;
+        size_t Size_;
+
+    public:
+        inline TBufferSlice()
+            : Size_(0)
+        {
+        }
+
+        inline TBufferSlice(std::shared_ptr<const char> data, size_t size)
+            : Data_(std::move(data))
+            , Size_(size)
+        {
+        }
+
+        // container should provide contiguous data() and size(), like
+        // std::string or std::vector<char>
+        template <class TContainer>
+        inline explicit TBufferSlice(
+            const std::shared_ptr<const TContainer>& buffer)
+            : Data_(buffer, buffer->data())
+            , Size_(buffer->size())
+        {
+        }
+
+        inline TBufferSlice Slice(size_t offset, size_t size) const
+        {
+            if (offset > Size_ || size > Size_ - offset)
+            {
+                throw std::out_of_range("Slice is out of buffer bounds");
+            }
+            return TBufferSlice(
+                std::shared_ptr<const char>(Data_, Data_.get() + offset),
+                size);
+        }
+
+        inline const char* Data() const
+        {
+            return Data_.get();
+        }
+
+        inline size_t Size() const
+        {
+            return Size_;
+        }
+
+        inline std::string_view View() const
+        {
+            return std::string_view(Data_.get(), Size_);
+        }
+    };
+
+    // decodes trivially copyable values stored as is
+    template <class TValue>
+    struct TPodCodec
+    {
+        static_assert(std::is_trivially_copyable<TValue>::value,
+            "Stored type should be trivially copyable");
+
+        static inline TValue Decode(std::string_view bytes)
+        {
+            if (bytes.size() != sizeof(TValue))
+            {
+                throw std::length_error("Wrong encoded value size");
+            }
+            TValue value;
+            std::memcpy(&value, bytes.data(), sizeof(TValue));
+            return value;
+        }
+    };
+
+    struct TStringCodec
+    {
+        static inline std::string Decode(std::string_view bytes)
+        {
+            return std::string(bytes);
+        }
+    };
+
+    namespace NPrivate
+    {
+        template <class TValue, class TCodec>
+        class TDecoder
+        {
+            // released after successful decoding, so decoded fields don't
+            // hold buffer
+            mutable TBufferSlice Bytes_;
+
+        public:
+            inline TDecoder(TBufferSlice bytes)
+                : Bytes_(std::move(bytes))
+            {
+            }
+
+            inline TValue operator () () const
+            {
+                TValue value(TCodec::Decode(Bytes_.View()));
+                Bytes_ = TBufferSlice();
+                return value;
+            }
+        };
+    }
+
+    // Lazy value, which is decoded from the slice of shared buffer by
+    // TCodec::Decode(std::string_view) on first access. Copies of undecoded
+    // values share bytes.
+    template <class TValue, class TCodec>
+    using TLazyDecoded = TLazy<TValue, NPrivate::TDecoder<TValue, TCodec>>;
+}
+
+#endif
+
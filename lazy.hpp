@@ -20,53 +20,102 @@
 #ifndef __LAZY_HPP_2011_08_07__
 #define __LAZY_HPP_2011_08_07__
 
+#include <cstddef>
 #include <functional>
+#include <memory>
 #include <new>
 #include <type_traits>
 #include <utility>
 
 namespace NReinventedWheels
 {
+    namespace NPrivate
+    {
+        // objects written by different threads are aligned to cache line
+        // size, so they don't share lines
+        constexpr size_t CacheLineSize = 64;
+    }
+
+    // tag for constructors, which calculate value immediately, so lazy
+    // variables declared constexpr or constinit can be calculated at compile
+    // time and used in constant expressions
+    struct TCalculateNow
+    {
+    };
+
+    constexpr TCalculateNow CalculateNow = TCalculateNow();
+
     template <class TValue>
     struct TLazyBase
     {
-        // use alignas(TValue) instead of union once it will be implemented in
-        // compiler
+        // values stored by constructors and assignments or calculated during
+        // constant evaluation live in Data_, so they can be read from
+        // constant expressions, while values calculated on first access at
+        // run time live in mutable LazyData_. Empty_ is active until then,
+        // so variables without values can be constant initialized.
         union TStorage {
             constexpr TStorage()
+                : Empty_()
             {
             }
 
-            inline ~TStorage()
+            constexpr ~TStorage()
             {
             }
 
+            char Empty_;
             TValue Data_;
+            mutable TValue LazyData_;
         } Storage_;
-        TValue& Value_;
+        bool Stored_;
         mutable bool Initialized_;
 
-        inline TLazyBase()
-            : Value_(Storage_.Data_)
+        constexpr TLazyBase()
+            : Stored_(false)
             , Initialized_(false)
         {
         }
 
-        inline ~TLazyBase()
+        constexpr ~TLazyBase()
+        {
+            if (Stored_) {
+                std::destroy_at(&Storage_.Data_);
+            } else if (!std::is_constant_evaluated() && Initialized_) {
+                std::destroy_at(&Storage_.LazyData_);
+            }
+        }
+
+        constexpr bool HasValue() const
         {
-            if (Initialized_) {
-                Value_.~TValue();
+            // non-mutable Stored_ is tested before anything else, so the
+            // check folds for constexpr objects, while mutable members can't
+            // be read in constant expressions at all
+            if (Stored_)
+            {
+                return true;
             }
+            return !std::is_constant_evaluated() && Initialized_;
+        }
+
+        constexpr TValue& Value()
+        {
+            return Stored_ ? Storage_.Data_ : Storage_.LazyData_;
+        }
+
+        constexpr const TValue& Value() const
+        {
+            return Stored_ ? Storage_.Data_ : Storage_.LazyData_;
         }
 
-        inline void Destroy()
+        constexpr void Destroy()
         {
-            Value_.~TValue();
+            std::destroy_at(&Value());
+            Stored_ = false;
             Initialized_ = false;
         }
     };
 
-    template <class TValue>
+    template <class TValue, class TCalculator = std::function<TValue(void)>>
     class TLazy : TLazyBase<TValue>
     {
         constexpr void ValidateCopyTraits()
@@ -78,26 +127,39 @@ namespace NReinventedWheels
                 "default constructible and copy assignable");
         }
         typedef TLazyBase<TValue> TBase;
-        using TBase::Value_;
+        using TBase::Storage_;
+        using TBase::Stored_;
         using TBase::Initialized_;
-        typedef std::function<TValue(void)> TCalculator;
+        using TBase::HasValue;
+        using TBase::Value;
         TCalculator Calculator_;
 
         inline void Calculate(std::true_type) const
         {
-            // TODO: check that move c'tor called here if present
-            new(&Value_) TValue(Calculator_());
+            // unlike std::construct_at, placement new elides move of
+            // calculated value
+            new(&Storage_.LazyData_) TValue(Calculator_());
         }
 
         inline void Calculate(std::false_type) const
         {
-            new(&Value_) TValue;
-            Value_ = this->Calculator();
+            new(&Storage_.LazyData_) TValue();
+            Storage_.LazyData_ = Calculator_();
         }
 
-        inline void Calculate() const
+        constexpr void Calculate() const
         {
-            if (!Initialized_)
+            if (HasValue())
+            {
+                return;
+            }
+            if (std::is_constant_evaluated())
+            {
+                // variables created during constant evaluation can be
+                // modified by it, while their mutable members can't be used
+                const_cast<TLazy*>(this)->ConstructValue(Calculator_());
+            }
+            else
             {
                 Calculate(std::__or_<std::is_copy_constructible<TValue>,
                     std::is_move_constructible<TValue>>());
@@ -105,200 +167,274 @@ namespace NReinventedWheels
             }
         }
 
-        inline void MoveNewValue(std::true_type, TValue&& value)
+        // calculator of initialized value is never called, so it isn't
+        // copied when it can be replaced by default constructed one, in
+        // order not to copy and hold resources it captures
+        static constexpr TCalculator CopyCalculator(std::true_type,
+            const TLazy& lazy)
+        {
+            return lazy.HasValue() ? TCalculator() : lazy.Calculator_;
+        }
+
+        static constexpr TCalculator CopyCalculator(std::false_type,
+            const TLazy& lazy)
+        {
+            return lazy.Calculator_;
+        }
+
+        static constexpr TCalculator MoveCalculator(std::true_type,
+            TLazy& lazy)
+        {
+            return lazy.HasValue() ?
+                TCalculator() : std::move(lazy.Calculator_);
+        }
+
+        static constexpr TCalculator MoveCalculator(std::false_type,
+            TLazy& lazy)
+        {
+            return std::move(lazy.Calculator_);
+        }
+
+        constexpr void ResetCalculator(std::true_type)
         {
-            new(&Value_) TValue;
-            Value_ = std::move(value);
+            Calculator_ = TCalculator();
         }
 
-        inline void MoveNewValue(std::false_type, TValue&& value)
+        constexpr void ResetCalculator(std::false_type)
+        {
+        }
+
+        // releases calculator once value is stored
+        constexpr void ResetCalculator()
+        {
+            ResetCalculator(std::conjunction<
+                std::is_default_constructible<TCalculator>,
+                std::is_move_assignable<TCalculator>>());
+        }
+
+        constexpr void MoveNewValue(std::true_type, TValue&& value)
+        {
+            std::construct_at(&Storage_.Data_);
+            Storage_.Data_ = std::move(value);
+            Stored_ = true;
+        }
+
+        constexpr void MoveNewValue(std::false_type, TValue&& value)
         {
             ConstructValue(value);
         }
 
-        inline void MoveNewValue(TValue&& value)
+        constexpr void MoveNewValue(TValue&& value)
         {
             MoveNewValue(std::is_move_assignable<TValue>(), std::move(value));
         }
 
-        inline void ConstructValue(std::true_type, const TValue& value)
+        constexpr void ConstructValue(std::true_type, const TValue& value)
         {
-            new(&Value_) TValue(value);
+            std::construct_at(&Storage_.Data_, value);
+            Stored_ = true;
         }
 
-        inline void ConstructValue(std::false_type, const TValue& value)
+        constexpr void ConstructValue(std::false_type, const TValue& value)
         {
-            new(&Value_) TValue;
-            Value_ = value;
+            std::construct_at(&Storage_.Data_);
+            Storage_.Data_ = value;
+            Stored_ = true;
         }
 
-        inline void ConstructValue(const TValue& value)
+        constexpr void ConstructValue(const TValue& value)
         {
             ConstructValue(std::is_copy_constructible<TValue>(), value);
         }
 
-        inline void ConstructValue(std::true_type, TValue&& value)
+        constexpr void ConstructValue(std::true_type, TValue&& value)
         {
-            new(&Value_) TValue(std::move(value));
+            std::construct_at(&Storage_.Data_, std::move(value));
+            Stored_ = true;
         }
 
-        inline void ConstructValue(std::false_type, TValue&& value)
+        constexpr void ConstructValue(std::false_type, TValue&& value)
         {
             MoveNewValue(std::move(value));
         }
 
-        inline void ConstructValue(TValue&& value)
+        constexpr void ConstructValue(TValue&& value)
         {
             ConstructValue(std::is_move_constructible<TValue>(),
                 std::move(value));
         }
 
-        inline void CopyValue(std::true_type, const TValue& value)
+        constexpr void CopyValue(std::true_type, const TValue& value)
         {
-            Value_ = value;
+            Value() = value;
         }
 
-        inline void CopyValue(std::false_type, const TValue& value)
+        constexpr void CopyValue(std::false_type, const TValue& value)
         {
             // TODO: provide strong guarantees here
-            Value_.~TValue();
-            new(&Value_) TValue(value);
+            this->Destroy();
+            ConstructValue(value);
         }
 
-        inline void CopyValue(const TValue& value)
+        constexpr void CopyValue(const TValue& value)
         {
             CopyValue(std::is_copy_assignable<TValue>(), value);
         }
 
         // TODO: rewrite next five functions, to have less functions
-        inline void MoveValue(std::true_type, TValue&& value)
+        constexpr void MoveValue(std::true_type, TValue&& value)
         {
-            Value_ = std::move(value);
+            Value() = std::move(value);
         }
 
-        inline void MoveValue(std::false_type, TValue&& value)
+        constexpr void MoveValue(std::false_type, TValue&& value)
         {
             // TODO: provide strong guarantees here
-            Value_.~TValue();
+            this->Destroy();
             ConstructValue(std::move(value));
         }
 
-        inline void MoveAssign(std::true_type, TValue&& value)
+        constexpr void MoveAssign(std::true_type, TValue&& value)
         {
             MoveValue(std::is_move_assignable<TValue>(), std::move(value));
         }
 
-        inline void MoveAssign(std::false_type, TValue&& value)
+        constexpr void MoveAssign(std::false_type, TValue&& value)
         {
             CopyValue(value);
         }
 
-        inline void MoveValue(TValue&& value)
+        constexpr void MoveValue(TValue&& value)
         {
             MoveAssign(std::__or_<std::is_move_constructible<TValue>,
                 std::is_move_assignable<TValue>>(), std::move(value));
         }
 
     public:
-        inline explicit TLazy(const TCalculator& calculator)
+        constexpr explicit TLazy(const TCalculator& calculator)
+            : Calculator_(calculator)
+        {
+        }
+
+        constexpr explicit TLazy(TCalculator&& calculator)
+            : Calculator_(std::move(calculator))
+        {
+        }
+
+        // stored value is readable in constant expressions, even if
+        // variable is declared constexpr, and leaves no calculations for run
+        // time
+        constexpr TLazy(TCalculateNow, const TCalculator& calculator)
             : Calculator_(calculator)
         {
+            ConstructValue(Calculator_());
         }
 
-        inline explicit TLazy(TCalculator&& calculator)
+        constexpr TLazy(TCalculateNow, TCalculator&& calculator)
             : Calculator_(std::move(calculator))
         {
+            ConstructValue(Calculator_());
         }
 
-        inline TLazy(const TLazy& lazy)
+        constexpr TLazy(const TLazy& lazy)
+            : Calculator_(CopyCalculator(
+                std::is_default_constructible<TCalculator>(), lazy))
         {
             ValidateCopyTraits();
-            if (lazy.Initialized_)
+            if (lazy.HasValue())
             {
-                ConstructValue(lazy.Value_);
-                Initialized_ = true;
-            }
-            else
-            {
-                Calculator_ = lazy.Calculator_;
+                ConstructValue(lazy.Value());
             }
         }
 
-        inline TLazy(TLazy&& lazy)
+        constexpr TLazy(TLazy&& lazy)
+            : Calculator_(MoveCalculator(
+                std::is_default_constructible<TCalculator>(), lazy))
         {
-            if (lazy.Initialized_)
+            if (lazy.HasValue())
             {
-                ConstructValue(std::move(lazy.Value_));
-                Initialized_ = true;
-            }
-            else
-            {
-                Calculator_ = std::move(lazy.Calculator_);
+                ConstructValue(std::move(lazy.Value()));
             }
         }
 
-        inline operator TValue&()
+        constexpr bool IsInitialized() const
+        {
+            return HasValue();
+        }
+
+        constexpr operator TValue&()
         {
             Calculate();
-            return Value_;
+            return Value();
         }
 
-        inline operator const TValue&() const
+        constexpr operator const TValue&() const
         {
             Calculate();
-            return Value_;
+            return Value();
         }
 
-        inline TLazy& operator = (const TValue& value)
+        constexpr TLazy& operator = (const TValue& value)
         {
             ValidateCopyTraits();
-            if (Initialized_)
+            if (HasValue())
             {
                 CopyValue(value);
             }
             else
             {
                 ConstructValue(value);
-                Initialized_ = true;
             }
+            ResetCalculator();
             return *this;
         }
 
-        inline TLazy& operator = (TValue&& value)
+        constexpr TLazy& operator = (TValue&& value)
         {
-            if (Initialized_)
+            if (HasValue())
             {
                 MoveValue(std::move(value));
             }
             else
             {
                 ConstructValue(std::move(value));
-                Initialized_ = true;
             }
+            ResetCalculator();
             return *this;
         }
 
-        inline TLazy& operator = (const TLazy& lazy)
+        // assignments and swap of lazy variables replace calculator, so
+        // they are unavailable for calculators which can't be assigned,
+        // like lambdas with captures. Deleted overloads keep such variables
+        // from being assigned through conversion to value, which would
+        // calculate the source.
+        TLazy& operator = (const TLazy&)
+            requires (!std::is_copy_assignable<TCalculator>::value) = delete;
+        TLazy& operator = (TLazy&&)
+            requires (!std::is_move_assignable<TCalculator>::value) = delete;
+
+        constexpr TLazy& operator = (const TLazy& lazy)
+            requires std::is_copy_assignable<TCalculator>::value
         {
             ValidateCopyTraits();
             if (this != &lazy)
             {
-                if (lazy.Initialized_)
+                if (lazy.HasValue())
                 {
-                    if (Initialized_)
+                    if (HasValue())
                     {
-                        CopyValue(lazy.Value_);
+                        CopyValue(lazy.Value());
                     }
                     else
                     {
-                        ConstructValue(lazy.Value_);
-                        Initialized_ = true;
+                        ConstructValue(lazy.Value());
                     }
+                    ResetCalculator();
                 }
                 else
                 {
                     Calculator_ = lazy.Calculator_;
-                    if (Initialized_)
+                    if (HasValue())
                     {
                         this->Destroy();
                     }
@@ -307,20 +443,21 @@ namespace NReinventedWheels
             return *this;
         }
 
-        inline TLazy& operator = (TLazy&& lazy)
+        constexpr TLazy& operator = (TLazy&& lazy)
+            requires std::is_move_assignable<TCalculator>::value
         {
-            if (lazy.Initialized_)
+            if (lazy.HasValue())
             {
-                if (Initialized_) {
-                    MoveValue(std::move(lazy.Value_));
+                if (HasValue()) {
+                    MoveValue(std::move(lazy.Value()));
                 } else {
-                    ConstructValue(std::move(lazy.Value_));
-                    Initialized_ = true;
+                    ConstructValue(std::move(lazy.Value()));
                 }
+                ResetCalculator();
             }
             else
             {
-                if (Initialized_) {
+                if (HasValue()) {
                     this->Destroy();
                 }
                 Calculator_ = std::move(lazy.Calculator_);
@@ -328,28 +465,28 @@ namespace NReinventedWheels
             return *this;
         }
 
-        inline void Swap(TLazy& lazy)
+        constexpr void Swap(TLazy& lazy)
+            requires std::is_move_constructible<TCalculator>::value &&
+                std::is_move_assignable<TCalculator>::value
         {
-            if (Initialized_)
+            if (HasValue())
             {
-                if (lazy.Initialized_)
+                if (lazy.HasValue())
                 {
-                    std::swap(Value_, lazy.Value_);
+                    std::swap(Value(), lazy.Value());
                 }
                 else
                 {
-                    lazy.MoveNewValue(std::move(Value_));
-                    lazy.Initialized_ = true;
+                    lazy.MoveNewValue(std::move(Value()));
                     Calculator_ = std::move(lazy.Calculator_);
                     this->Destroy();
                 }
             }
             else
             {
-                if (lazy.Initialized_)
+                if (lazy.HasValue())
                 {
-                    MoveNewValue(std::move(lazy.Value_));
-                    Initialized_ = true;
+                    MoveNewValue(std::move(lazy.Value()));
                     lazy.Calculator_ = std::move(Calculator_);
                     lazy.Destroy();
                 }
@@ -360,12 +497,23 @@ namespace NReinventedWheels
             }
         }
     };
+
+    // allows to declare lazy variables with calculator type deduced, such
+    // variables can be used in constant expressions
+    template <class TCalculator>
+    TLazy(TCalculator) -> TLazy<
+        std::decay_t<std::invoke_result_t<const TCalculator&>>, TCalculator>;
+
+    template <class TCalculator>
+    TLazy(TCalculateNow, TCalculator) -> TLazy<
+        std::decay_t<std::invoke_result_t<const TCalculator&>>, TCalculator>;
 }
 
 namespace std {
-    template <class TValue>
-    void swap(NReinventedWheels::TLazy<TValue>& lhs,
-        NReinventedWheels::TLazy<TValue>& rhs)
+    template <class TValue, class TCalculator>
+    void swap(NReinventedWheels::TLazy<TValue, TCalculator>& lhs,
+        NReinventedWheels::TLazy<TValue, TCalculator>& rhs)
+        requires requires { lhs.Swap(rhs); }
     {
         lhs.Swap(rhs);
     }
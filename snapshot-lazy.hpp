@@ -0,0 +1,377 @@
+/*
+ * snapshot-lazy.hpp        -- lazy evaluating variables with lock-free
+ *                             publication of new versions
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SNAPSHOT_LAZY_HPP_2026_10_18__
+#define __SNAPSHOT_LAZY_HPP_2026_10_18__
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "lazy.hpp"
+
+namespace NReinventedWheels
+{
+    namespace NPrivate
+    {
+        // reader slot of a single thread, slots are never freed, but reused
+        // by new threads after their owners exit
+        struct alignas(CacheLineSize) TEpochSlot
+        {
+            // epoch observed on critical section entry, zero if thread is
+            // outside of critical section
+            std::atomic<size_t> Epoch_;
+            std::atomic<bool> Used_;
+            TEpochSlot* Next_;
+            // accessed by owner thread only
+            size_t Depth_;
+
+            inline TEpochSlot()
+                : Epoch_(0)
+                , Used_(true)
+                , Next_(nullptr)
+                , Depth_(0)
+            {
+            }
+        };
+
+        class TEpochDomain
+        {
+            std::atomic<size_t> Epoch_;
+            std::atomic<TEpochSlot*> Slots_;
+
+            inline TEpochDomain()
+                : Epoch_(1)
+                , Slots_(nullptr)
+            {
+            }
+
+        public:
+            // never destroyed, so threads can release their slots after
+            // static objects destruction
+            static inline TEpochDomain& Instance()
+            {
+                static TEpochDomain* domain = new TEpochDomain;
+                return *domain;
+            }
+
+            inline TEpochSlot* AcquireSlot()
+            {
+                for (TEpochSlot* slot = Slots_.load(); slot;
+                    slot = slot->Next_)
+                {
+                    bool used = false;
+                    if (!slot->Used_.load(std::memory_order_relaxed) &&
+                        slot->Used_.compare_exchange_strong(used, true))
+                    {
+                        return slot;
+                    }
+                }
+                TEpochSlot* slot = new TEpochSlot;
+                slot->Next_ = Slots_.load();
+                while (!Slots_.compare_exchange_weak(slot->Next_, slot))
+                {
+                }
+                return slot;
+            }
+
+            inline void ReleaseSlot(TEpochSlot* slot)
+            {
+                slot->Used_.store(false);
+            }
+
+            inline void Enter(TEpochSlot* slot)
+            {
+                if (slot->Depth_++ == 0)
+                {
+                    slot->Epoch_.store(Epoch_.load());
+                }
+            }
+
+            inline void Leave(TEpochSlot* slot)
+            {
+                if (--slot->Depth_ == 0)
+                {
+                    slot->Epoch_.store(0, std::memory_order_release);
+                }
+            }
+
+            // returns epoch in which objects unlinked before call are
+            // retired
+            inline size_t Advance()
+            {
+                return Epoch_.fetch_add(1);
+            }
+
+            // objects retired in epochs less than returned value can't be
+            // accessed by any reader
+            inline size_t MinActiveEpoch() const
+            {
+                size_t result = std::numeric_limits<size_t>::max();
+                for (TEpochSlot* slot = Slots_.load(); slot;
+                    slot = slot->Next_)
+                {
+                    size_t epoch = slot->Epoch_.load();
+                    if (epoch && epoch < result)
+                    {
+                        result = epoch;
+                    }
+                }
+                return result;
+            }
+        };
+
+        class TEpochThread
+        {
+            TEpochSlot* Slot_;
+
+        public:
+            inline TEpochThread()
+                : Slot_(TEpochDomain::Instance().AcquireSlot())
+            {
+            }
+
+            inline ~TEpochThread()
+            {
+                TEpochDomain::Instance().ReleaseSlot(Slot_);
+            }
+
+            static inline TEpochSlot* CurrentSlot()
+            {
+                static thread_local TEpochThread thread;
+                return thread.Slot_;
+            }
+        };
+
+        template <class TValue>
+        class TSnapshotVersion
+        {
+            TLazy<TValue> Value_;
+            std::atomic<bool> Calculated_;
+            std::mutex Lock_;
+
+        public:
+            inline explicit TSnapshotVersion(
+                std::function<TValue(void)>&& calculator)
+                : Value_(std::move(calculator))
+                , Calculated_(false)
+            {
+            }
+
+            template <class TArg>
+            inline TSnapshotVersion(std::function<TValue(void)>&& calculator,
+                TArg&& value)
+                : Value_(std::move(calculator))
+                , Calculated_(true)
+            {
+                Value_ = std::forward<TArg>(value);
+            }
+
+            inline const TValue& Get()
+            {
+                if (!Calculated_.load(std::memory_order_acquire))
+                {
+                    std::lock_guard<std::mutex> guard(Lock_);
+                    if (!Calculated_.load(std::memory_order_relaxed))
+                    {
+                        static_cast<void>(static_cast<TValue&>(Value_));
+                        Calculated_.store(true, std::memory_order_release);
+                    }
+                }
+                return Value_;
+            }
+        };
+    }
+
+    // Handle to immutable version of TSnapshotLazy value. Version stays alive
+    // until handle destruction, regardless of new versions published.
+    // Handle should be destroyed by the same thread which obtained it.
+    template <class TValue>
+    class TSnapshot
+    {
+        template <class>
+        friend class TSnapshotLazy;
+
+        typedef NPrivate::TSnapshotVersion<TValue> TVersion;
+        NPrivate::TEpochSlot* Slot_;
+        TVersion* Version_;
+
+        inline TSnapshot(NPrivate::TEpochSlot* slot,
+            const std::atomic<TVersion*>& version)
+            : Slot_(slot)
+        {
+            NPrivate::TEpochDomain::Instance().Enter(Slot_);
+            Version_ = version.load();
+        }
+
+        TSnapshot(const TSnapshot&) = delete;
+        TSnapshot& operator = (const TSnapshot&) = delete;
+
+    public:
+        inline TSnapshot(TSnapshot&& snapshot)
+            : Slot_(snapshot.Slot_)
+            , Version_(snapshot.Version_)
+        {
+            snapshot.Slot_ = nullptr;
+        }
+
+        inline ~TSnapshot()
+        {
+            if (Slot_)
+            {
+                NPrivate::TEpochDomain::Instance().Leave(Slot_);
+            }
+        }
+
+        inline operator const TValue&() const
+        {
+            return Version_->Get();
+        }
+
+        inline const TValue& operator * () const
+        {
+            return Version_->Get();
+        }
+
+        inline const TValue* operator -> () const
+        {
+            return &Version_->Get();
+        }
+    };
+
+    // Lazy evaluating variable which can be safely read and replaced
+    // concurrently. Readers take wait-free snapshots of current version,
+    // while writers publish new versions, which will be calculated on first
+    // access. Replaced versions are destroyed by the next Publish(),
+    // assignment or Reclaim() call made after all snapshots, taken before
+    // replacement, are gone.
+    template <class TValue>
+    class TSnapshotLazy
+    {
+        typedef std::function<TValue(void)> TCalculator;
+        typedef NPrivate::TSnapshotVersion<TValue> TVersion;
+        typedef std::unique_ptr<TVersion> TVersionPtr;
+        typedef std::pair<TVersion*, size_t> TRetired;
+
+        std::atomic<TVersion*> Version_;
+        std::mutex Lock_;
+        std::vector<TRetired> Retired_;
+
+        TSnapshotLazy(const TSnapshotLazy&) = delete;
+        TSnapshotLazy& operator = (const TSnapshotLazy&) = delete;
+
+        inline void Replace(TVersionPtr version)
+        {
+            NPrivate::TEpochDomain& domain =
+                NPrivate::TEpochDomain::Instance();
+            std::lock_guard<std::mutex> guard(Lock_);
+            Retired_.push_back(TRetired(nullptr, 0));
+            Retired_.back().first = Version_.exchange(version.release());
+            Retired_.back().second = domain.Advance();
+            Collect();
+        }
+
+        // should be called under Lock_
+        inline void Collect()
+        {
+            size_t minEpoch =
+                NPrivate::TEpochDomain::Instance().MinActiveEpoch();
+            size_t size = 0;
+            for (size_t i = 0; i < Retired_.size(); ++i)
+            {
+                if (Retired_[i].second < minEpoch)
+                {
+                    delete Retired_[i].first;
+                }
+                else
+                {
+                    Retired_[size++] = Retired_[i];
+                }
+            }
+            Retired_.resize(size);
+        }
+
+    public:
+        inline explicit TSnapshotLazy(const TCalculator& calculator)
+            : Version_(new TVersion(TCalculator(calculator)))
+        {
+        }
+
+        inline explicit TSnapshotLazy(TCalculator&& calculator)
+            : Version_(new TVersion(std::move(calculator)))
+        {
+        }
+
+        // all snapshots should be destroyed before
+        inline ~TSnapshotLazy()
+        {
+            for (size_t i = 0; i < Retired_.size(); ++i)
+            {
+                delete Retired_[i].first;
+            }
+            delete Version_.load();
+        }
+
+        // destroys replaced versions, which are no longer referenced by
+        // snapshots, without publishing new version
+        inline void Reclaim()
+        {
+            std::lock_guard<std::mutex> guard(Lock_);
+            Collect();
+        }
+
+        inline TSnapshot<TValue> Snapshot() const
+        {
+            return TSnapshot<TValue>(NPrivate::TEpochThread::CurrentSlot(),
+                Version_);
+        }
+
+        inline void Publish(const TCalculator& calculator)
+        {
+            Replace(TVersionPtr(new TVersion(TCalculator(calculator))));
+        }
+
+        inline void Publish(TCalculator&& calculator)
+        {
+            Replace(TVersionPtr(new TVersion(std::move(calculator))));
+        }
+
+        inline TSnapshotLazy& operator = (const TValue& value)
+        {
+            Replace(TVersionPtr(new TVersion(TCalculator(), value)));
+            return *this;
+        }
+
+        inline TSnapshotLazy& operator = (TValue&& value)
+        {
+            Replace(TVersionPtr(
+                new TVersion(TCalculator(), std::move(value))));
+            return *this;
+        }
+    };
+}
+
+#endif
+
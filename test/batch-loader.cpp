@@ -0,0 +1,229 @@
+/*
+ * batch-loader.cpp         -- lazy evaluating variables loaded in batches
+ *                             tests
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <batch-loader.hpp>
+#include <force-all.hpp>
+using NReinventedWheels::ForceAll;
+using NReinventedWheels::TBatchLoader;
+using NReinventedWheels::TLazy;
+namespace NExecution = NReinventedWheels::NExecution;
+
+#define BOOST_TEST_MODULE BatchLoaderTest
+#include <boost/test/unit_test.hpp>
+
+struct TSquaresLoader
+{
+    int& Calls_;
+    std::vector<int>& Keys_;
+
+    inline std::vector<int> operator () (const std::vector<int>& keys) const
+    {
+        ++Calls_;
+        Keys_ = keys;
+        std::vector<int> values;
+        for (int key: keys)
+        {
+            values.push_back(key * key);
+        }
+        return values;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(single_batch)
+{
+    int calls = 0;
+    std::vector<int> keys;
+    TBatchLoader<int, int> loader(TSquaresLoader{calls, keys});
+    std::vector<TLazy<int>> lazies;
+    for (int i = 0; i < 10; ++i)
+    {
+        lazies.push_back(loader.Lazy(i));
+    }
+    BOOST_REQUIRE_EQUAL(calls, 0);
+    BOOST_REQUIRE_EQUAL(lazies[3], 9);
+    BOOST_REQUIRE_EQUAL(calls, 1);
+    BOOST_REQUIRE_EQUAL(keys.size(), 10u);
+    for (int i = 0; i < 10; ++i)
+    {
+        BOOST_REQUIRE_EQUAL(lazies[i], i * i);
+    }
+    BOOST_REQUIRE_EQUAL(calls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(batch_windows)
+{
+    int calls = 0;
+    std::vector<int> keys;
+    TBatchLoader<int, int> loader(TSquaresLoader{calls, keys});
+    TLazy<int> first(loader.Lazy(1));
+    TLazy<int> second(loader.Lazy(2));
+    BOOST_REQUIRE_EQUAL(first, 1);
+    TLazy<int> third(loader.Lazy(3));
+    TLazy<int> fourth(loader.Lazy(4));
+    BOOST_REQUIRE_EQUAL(second, 4);
+    BOOST_REQUIRE_EQUAL(calls, 1);
+    BOOST_REQUIRE_EQUAL(fourth, 16);
+    BOOST_REQUIRE_EQUAL(calls, 2);
+    BOOST_REQUIRE(keys == std::vector<int>({3, 4}));
+    BOOST_REQUIRE_EQUAL(third, 9);
+    BOOST_REQUIRE_EQUAL(calls, 2);
+}
+
+BOOST_AUTO_TEST_CASE(flush)
+{
+    int calls = 0;
+    std::vector<int> keys;
+    TBatchLoader<int, int> loader(TSquaresLoader{calls, keys});
+    TLazy<int> first(loader.Lazy(1));
+    loader.Flush();
+    BOOST_REQUIRE_EQUAL(calls, 1);
+    TLazy<int> second(loader.Lazy(2));
+    loader.Flush();
+    loader.Flush();
+    BOOST_REQUIRE_EQUAL(calls, 2);
+    BOOST_REQUIRE_EQUAL(first, 1);
+    BOOST_REQUIRE_EQUAL(second, 4);
+    BOOST_REQUIRE_EQUAL(calls, 2);
+}
+
+BOOST_AUTO_TEST_CASE(outlive_loader)
+{
+    int calls = 0;
+    std::vector<int> keys;
+    std::vector<TLazy<int>> lazies;
+    {
+        TBatchLoader<int, int> loader(TSquaresLoader{calls, keys});
+        lazies.push_back(loader.Lazy(5));
+        lazies.push_back(loader.Lazy(6));
+    }
+    BOOST_REQUIRE_EQUAL(lazies[1], 36);
+    BOOST_REQUIRE_EQUAL(lazies[0], 25);
+    BOOST_REQUIRE_EQUAL(calls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(parallel)
+{
+    int calls = 0;
+    std::vector<int> keys;
+    TBatchLoader<int, int> loader(TSquaresLoader{calls, keys});
+    std::vector<TLazy<int>> lazies;
+    for (int i = 0; i < 1000; ++i)
+    {
+        lazies.push_back(loader.Lazy(i));
+    }
+    ForceAll(lazies.begin(), lazies.end(), NExecution::Par, 4);
+    BOOST_REQUIRE_EQUAL(calls, 1);
+    BOOST_REQUIRE_EQUAL(lazies[999], 999 * 999);
+}
+
+BOOST_AUTO_TEST_CASE(errors)
+{
+    int calls = 0;
+    TBatchLoader<int, int> loader([&calls](const std::vector<int>& keys)
+        {
+            if (++calls == 1)
+            {
+                throw std::runtime_error("backend is unavailable");
+            }
+            return std::vector<int>(keys.size() + (calls == 2), 1);
+        });
+    TLazy<int> first(loader.Lazy(1));
+    TLazy<int> second(loader.Lazy(2));
+    BOOST_REQUIRE_THROW(static_cast<int>(first), std::runtime_error);
+    BOOST_REQUIRE_THROW(static_cast<int>(second), std::length_error);
+    BOOST_REQUIRE_EQUAL(first, 1);
+    BOOST_REQUIRE_EQUAL(second, 1);
+    BOOST_REQUIRE_EQUAL(calls, 3);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_load)
+{
+    std::atomic<bool> loading(false), created(false);
+    // returns ones only if another lazy value was created during load
+    TBatchLoader<int, int> loader(
+        [&loading, &created](const std::vector<int>& keys)
+        {
+            loading.store(true);
+            for (int i = 0; i < 5000 && !created.load(); ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            return std::vector<int>(keys.size(), created.load());
+        });
+    TLazy<int> first(loader.Lazy(1));
+    std::thread thread([&first]()
+        { static_cast<void>(static_cast<int&>(first)); });
+    while (!loading.load())
+    {
+        std::this_thread::yield();
+    }
+    TLazy<int> second(loader.Lazy(2));
+    created.store(true);
+    thread.join();
+    BOOST_REQUIRE_EQUAL(first, 1);
+    BOOST_REQUIRE_EQUAL(second, 1);
+}
+
+BOOST_AUTO_TEST_CASE(dead_keys)
+{
+    int calls = 0;
+    std::vector<int> keys;
+    TBatchLoader<int, int> loader(TSquaresLoader{calls, keys});
+    TLazy<int> first(loader.Lazy(1));
+    {
+        TLazy<int> second(loader.Lazy(2));
+    }
+    TLazy<int> third(loader.Lazy(3));
+    third = 0;
+    TLazy<int> fourth(loader.Lazy(4));
+    TLazy<int> copy(fourth);
+    BOOST_REQUIRE_EQUAL(first, 1);
+    BOOST_REQUIRE(keys == std::vector<int>({1, 4}));
+    BOOST_REQUIRE_EQUAL(fourth, 16);
+    BOOST_REQUIRE_EQUAL(copy, 16);
+    BOOST_REQUIRE_EQUAL(third, 0);
+    BOOST_REQUIRE_EQUAL(calls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(values_release)
+{
+    typedef std::shared_ptr<int> TPtr;
+    TPtr value(new int(1));
+    TBatchLoader<int, TPtr> loader([&value](const std::vector<int>& keys)
+        { return std::vector<TPtr>(keys.size(), value); });
+    TLazy<TPtr> first(loader.Lazy(1));
+    TLazy<TPtr> copy(first);
+    loader.Flush();
+    BOOST_REQUIRE_EQUAL(value.use_count(), 2);
+    BOOST_REQUIRE(static_cast<TPtr&>(first) == value);
+    BOOST_REQUIRE_EQUAL(value.use_count(), 3);
+    BOOST_REQUIRE(static_cast<TPtr&>(copy) == value);
+    BOOST_REQUIRE_EQUAL(value.use_count(), 3);
+    TLazy<TPtr> calculatedCopy(copy);
+    BOOST_REQUIRE_EQUAL(value.use_count(), 4);
+}
+
@@ -1,3 +1,13 @@
 #include <lazy.hpp>
 #include <lazy.hpp>
+#include <force-all.hpp>
+#include <force-all.hpp>
+#include <snapshot-lazy.hpp>
+#include <snapshot-lazy.hpp>
+#include <thread-local-lazy.hpp>
+#include <thread-local-lazy.hpp>
+#include <batch-loader.hpp>
+#include <batch-loader.hpp>
+#include <lazy-decoded.hpp>
+#include <lazy-decoded.hpp>
 
@@ -0,0 +1,129 @@
+/*
+ * force-all.cpp            -- lazy values ranges evaluation tests
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include <force-all.hpp>
+using NReinventedWheels::ForceAll;
+namespace NExecution = NReinventedWheels::NExecution;
+using NReinventedWheels::TLazy;
+
+#define BOOST_TEST_MODULE ForceAllTest
+#include <boost/test/unit_test.hpp>
+
+std::vector<TLazy<int>> MakeLazies(int size, std::atomic<int>& flag)
+{
+    std::vector<TLazy<int>> lazies;
+    for (int i = 0; i < size; ++i)
+    {
+        lazies.emplace_back([i, &flag](){ return (++flag, i * 2); });
+    }
+    return lazies;
+}
+
+BOOST_AUTO_TEST_CASE(sequenced)
+{
+    std::atomic<int> flag(0);
+    std::vector<TLazy<int>> lazies(MakeLazies(10, flag));
+    ForceAll(lazies.begin(), lazies.end(), NExecution::Seq);
+    BOOST_REQUIRE_EQUAL(flag, 10);
+    for (int i = 0; i < 10; ++i)
+    {
+        BOOST_REQUIRE(lazies[i].IsInitialized());
+        BOOST_REQUIRE_EQUAL(lazies[i], i * 2);
+    }
+    BOOST_REQUIRE_EQUAL(flag, 10);
+}
+
+BOOST_AUTO_TEST_CASE(parallel)
+{
+    std::atomic<int> flag(0);
+    std::vector<TLazy<int>> lazies(MakeLazies(1000, flag));
+    ForceAll(lazies.begin(), lazies.end(), NExecution::Par, 4);
+    BOOST_REQUIRE_EQUAL(flag, 1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        BOOST_REQUIRE_EQUAL(lazies[i], i * 2);
+    }
+    BOOST_REQUIRE_EQUAL(flag, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_unsequenced)
+{
+    std::atomic<int> flag(0);
+    std::vector<TLazy<int>> lazies(MakeLazies(1000, flag));
+    ForceAll(lazies.begin(), lazies.end(), NExecution::ParUnseq);
+    BOOST_REQUIRE_EQUAL(flag, 1000);
+    for (int i = 0; i < 1000; ++i)
+    {
+        BOOST_REQUIRE_EQUAL(lazies[i], i * 2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(skip_initialized)
+{
+    std::atomic<int> flag(0);
+    std::vector<TLazy<int>> lazies(MakeLazies(100, flag));
+    BOOST_REQUIRE_EQUAL(lazies[3], 6);
+    lazies[5] = 1;
+    BOOST_REQUIRE_EQUAL(flag, 1);
+    ForceAll(lazies.begin(), lazies.end(), NExecution::Par, 3);
+    BOOST_REQUIRE_EQUAL(flag, 99);
+    BOOST_REQUIRE_EQUAL(lazies[5], 1);
+    ForceAll(lazies.begin(), lazies.end(), NExecution::Seq);
+    ForceAll(lazies.begin(), lazies.end(), NExecution::Par, 3);
+    BOOST_REQUIRE_EQUAL(flag, 99);
+}
+
+BOOST_AUTO_TEST_CASE(map)
+{
+    std::atomic<int> flag(0);
+    std::map<int, TLazy<int>> lazies;
+    for (int i = 0; i < 100; ++i)
+    {
+        lazies.emplace(i, TLazy<int>([i, &flag](){ return (++flag, -i); }));
+    }
+    ForceAll(lazies.begin(), lazies.end(), NExecution::Par, 2);
+    BOOST_REQUIRE_EQUAL(flag, 100);
+    for (const auto& item: lazies)
+    {
+        BOOST_REQUIRE_EQUAL(item.second, -item.first);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(exception)
+{
+    std::vector<TLazy<int>> lazies;
+    for (int i = 0; i < 100; ++i)
+    {
+        lazies.emplace_back([i]()
+            { return i == 42 ? throw std::runtime_error("42") : i; });
+    }
+    BOOST_REQUIRE_THROW(
+        ForceAll(lazies.begin(), lazies.end(), NExecution::Par, 4),
+        std::runtime_error);
+    BOOST_REQUIRE(!lazies[42].IsInitialized());
+    BOOST_REQUIRE_THROW(
+        ForceAll(lazies.begin(), lazies.end(), NExecution::Seq),
+        std::runtime_error);
+}
+
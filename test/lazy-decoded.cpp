@@ -0,0 +1,109 @@
+/*
+ * lazy-decoded.cpp         -- lazy decoded fields over shared byte buffers
+ *                             tests
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <lazy-decoded.hpp>
+using NReinventedWheels::TBufferSlice;
+using NReinventedWheels::TLazyDecoded;
+using NReinventedWheels::TPodCodec;
+using NReinventedWheels::TStringCodec;
+
+#define BOOST_TEST_MODULE LazyDecodedTest
+#include <boost/test/unit_test.hpp>
+
+std::shared_ptr<const std::string> MakeBuffer()
+{
+    int number = 42;
+    std::string buffer(reinterpret_cast<const char*>(&number),
+        sizeof(number));
+    buffer += "hello, world";
+    return std::make_shared<const std::string>(buffer);
+}
+
+int DecodeCalls = 0;
+
+struct TCountingCodec
+{
+    static inline std::string Decode(std::string_view bytes)
+    {
+        ++DecodeCalls;
+        return std::string(bytes);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(slice)
+{
+    std::shared_ptr<const std::string> buffer(MakeBuffer());
+    TBufferSlice bytes(buffer);
+    BOOST_REQUIRE_EQUAL(bytes.Size(), buffer->size());
+    BOOST_REQUIRE_EQUAL(bytes.Data(), buffer->data());
+    TBufferSlice hello(bytes.Slice(sizeof(int), 5));
+    BOOST_REQUIRE(hello.View() == "hello");
+    BOOST_REQUIRE(hello.Slice(5, 0).View().empty());
+    BOOST_REQUIRE_THROW(hello.Slice(3, 3), std::out_of_range);
+    BOOST_REQUIRE_THROW(hello.Slice(6, 0), std::out_of_range);
+    BOOST_REQUIRE_EQUAL(buffer.use_count(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(decode)
+{
+    TBufferSlice bytes(MakeBuffer());
+    TLazyDecoded<int, TPodCodec<int>> number(bytes.Slice(0, sizeof(int)));
+    TLazyDecoded<std::string, TStringCodec> text(
+        bytes.Slice(sizeof(int), bytes.Size() - sizeof(int)));
+    BOOST_REQUIRE_EQUAL(number, 42);
+    BOOST_REQUIRE_EQUAL(static_cast<const std::string&>(text),
+        "hello, world");
+    TLazyDecoded<int, TPodCodec<int>> wrong(bytes.Slice(0, 3));
+    BOOST_REQUIRE_THROW(static_cast<int>(wrong), std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(decode_once)
+{
+    DecodeCalls = 0;
+    TBufferSlice bytes(MakeBuffer());
+    TLazyDecoded<std::string, TCountingCodec> text(bytes.Slice(4, 5));
+    BOOST_REQUIRE_EQUAL(DecodeCalls, 0);
+    BOOST_REQUIRE_EQUAL(static_cast<std::string&>(text), "hello");
+    BOOST_REQUIRE_EQUAL(static_cast<std::string&>(text), "hello");
+    BOOST_REQUIRE_EQUAL(DecodeCalls, 1);
+}
+
+BOOST_AUTO_TEST_CASE(shared_bytes)
+{
+    std::shared_ptr<const std::string> buffer(MakeBuffer());
+    typedef TLazyDecoded<std::string, TStringCodec> TText;
+    TText text(TBufferSlice(buffer).Slice(4, 5));
+    BOOST_REQUIRE_EQUAL(buffer.use_count(), 2);
+    {
+        TText copy(text);
+        BOOST_REQUIRE_EQUAL(buffer.use_count(), 3);
+        BOOST_REQUIRE_EQUAL(static_cast<std::string&>(copy), "hello");
+        BOOST_REQUIRE_EQUAL(buffer.use_count(), 2);
+    }
+    BOOST_REQUIRE_EQUAL(static_cast<std::string&>(text), "hello");
+    BOOST_REQUIRE_EQUAL(buffer.use_count(), 1);
+}
+
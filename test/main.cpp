@@ -17,9 +17,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <memory>
+#include <type_traits>
 #include <utility>
 
 #include <lazy.hpp>
+using NReinventedWheels::CalculateNow;
 using NReinventedWheels::TLazy;
 
 #define BOOST_TEST_MODULE LazyTest
@@ -73,7 +76,7 @@ BOOST_AUTO_TEST_CASE(recursive_calls)
 
 BOOST_AUTO_TEST_CASE(value_access1)
 {
-    bool flag = 0;
+    int flag = 0;
     TLazy<int> one([&flag](){ return (++flag, 1); });
     int& i = one;
     BOOST_REQUIRE_EQUAL(i, 1);
@@ -186,7 +189,7 @@ TLazy<int> MakeUsedLazy(int value)
 {
     TLazy<int> lazy(MakeLazy(value));
     static_cast<void>(static_cast<int>(lazy));
-    return std::move(lazy);
+    return lazy;
 }
 
 BOOST_AUTO_TEST_CASE(constuctor7)
@@ -322,6 +325,22 @@ BOOST_AUTO_TEST_CASE(assignment10)
     BOOST_REQUIRE_EQUAL(secondFlag, 3);
 }
 
+BOOST_AUTO_TEST_CASE(calculator_release)
+{
+    std::shared_ptr<int> value(new int(1));
+    TLazy<int> lazy([value](){ return *value; });
+    BOOST_REQUIRE_EQUAL(value.use_count(), 2);
+    TLazy<int> copy(lazy);
+    BOOST_REQUIRE_EQUAL(value.use_count(), 3);
+    BOOST_REQUIRE_EQUAL(lazy, 1);
+    TLazy<int> calculatedCopy(lazy);
+    TLazy<int> calculatedMove(std::move(calculatedCopy));
+    BOOST_REQUIRE_EQUAL(value.use_count(), 3);
+    copy = 2;
+    BOOST_REQUIRE_EQUAL(value.use_count(), 2);
+    BOOST_REQUIRE_EQUAL(copy, 2);
+}
+
 BOOST_AUTO_TEST_CASE(swap1)
 {
     int firstFlag = 0;
@@ -388,6 +407,111 @@ BOOST_AUTO_TEST_CASE(swap4)
     BOOST_REQUIRE_EQUAL(secondFlag, 3);
 }
 
+constexpr int CalculateSum()
+{
+    TLazy first([](){ return 2; });
+    TLazy second([&first](){ return first + 3; });
+    return second;
+}
+
+BOOST_AUTO_TEST_CASE(constant_expression1)
+{
+    constexpr TLazy five(CalculateNow, [](){ return 2 + 3; });
+    static_assert(five == 5, "constant expression expected");
+    BOOST_REQUIRE(five.IsInitialized());
+    BOOST_REQUIRE_EQUAL(five, 5);
+}
+
+BOOST_AUTO_TEST_CASE(constant_expression2)
+{
+    static_assert(CalculateSum() == 5, "constant expression expected");
+    BOOST_REQUIRE_EQUAL(CalculateSum(), 5);
+}
+
+constexpr int CalculateLate()
+{
+    int value = 0;
+    TLazy lazy([&value](){ return value; });
+    value = 5;
+    return lazy;
+}
+
+constexpr int CalculateGuarded(int divisor)
+{
+    TLazy quotient([divisor](){ return 10 / divisor; });
+    return divisor ? static_cast<int>(quotient) : 0;
+}
+
+BOOST_AUTO_TEST_CASE(constant_laziness)
+{
+    static_assert(CalculateLate() == 5, "lazy calculation expected");
+    BOOST_REQUIRE_EQUAL(CalculateLate(), 5);
+    static_assert(CalculateGuarded(0) == 0, "lazy calculation expected");
+    static_assert(CalculateGuarded(5) == 2, "lazy calculation expected");
+}
+
+struct TSquares
+{
+    int Data_[16];
+};
+
+constexpr TSquares CalculateSquares()
+{
+    TSquares squares = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        squares.Data_[i] = i * i;
+    }
+    return squares;
+}
+
+constinit TLazy Squares(CalculateNow, &CalculateSquares);
+constinit TLazy LazySquares(&CalculateSquares);
+
+BOOST_AUTO_TEST_CASE(constant_initialization)
+{
+    BOOST_REQUIRE(Squares.IsInitialized());
+    BOOST_REQUIRE_EQUAL(static_cast<TSquares&>(Squares).Data_[15], 225);
+    BOOST_REQUIRE(!LazySquares.IsInitialized());
+    BOOST_REQUIRE_EQUAL(static_cast<TSquares&>(LazySquares).Data_[3], 9);
+}
+
+BOOST_AUTO_TEST_CASE(deduced_calculator)
+{
+    int flag = 0;
+    TLazy lazy([&flag](){ return (++flag, 1); });
+    BOOST_REQUIRE(!lazy.IsInitialized());
+    BOOST_REQUIRE_EQUAL(flag, 0);
+    BOOST_REQUIRE_EQUAL(lazy, 1);
+    BOOST_REQUIRE_EQUAL(flag, 1);
+    TLazy copy(lazy);
+    BOOST_REQUIRE_EQUAL(copy, 1);
+    BOOST_REQUIRE_EQUAL(flag, 1);
+    copy = 2;
+    BOOST_REQUIRE_EQUAL(copy, 2);
+    typedef decltype(lazy) TCapturing;
+    static_assert(!std::is_copy_assignable<TCapturing>::value,
+        "lambdas with captures can't be assigned");
+    static_assert(!std::is_move_assignable<TCapturing>::value,
+        "lambdas with captures can't be assigned");
+    static_assert(!std::is_swappable<TCapturing>::value,
+        "lambdas with captures can't be assigned");
+}
+
+BOOST_AUTO_TEST_CASE(deduced_assignment)
+{
+    auto one = [](){ return 1; };
+    TLazy first(one);
+    TLazy second(one);
+    first = 3;
+    second = first;
+    BOOST_REQUIRE_EQUAL(second, 3);
+    TLazy third(one);
+    std::swap(first, third);
+    BOOST_REQUIRE_EQUAL(first, 1);
+    BOOST_REQUIRE_EQUAL(third, 3);
+}
+
 /* TODO: uncomment this once alingas will be implemented in compiler
 BOOST_AUTO_TEST_CASE(refs)
 {
@@ -0,0 +1,177 @@
+/*
+ * snapshot-lazy.cpp        -- lazy evaluating variables with lock-free
+ *                             publication of new versions tests
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <snapshot-lazy.hpp>
+using NReinventedWheels::TSnapshot;
+using NReinventedWheels::TSnapshotLazy;
+namespace NPrivate = NReinventedWheels::NPrivate;
+
+#define BOOST_TEST_MODULE SnapshotLazyTest
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(calculate_once)
+{
+    int flag = 0;
+    TSnapshotLazy<int> lazy([&flag](){ return (++flag, 5); });
+    BOOST_REQUIRE_EQUAL(flag, 0);
+    BOOST_REQUIRE_EQUAL(lazy.Snapshot(), 5);
+    BOOST_REQUIRE_EQUAL(*lazy.Snapshot(), 5);
+    BOOST_REQUIRE_EQUAL(flag, 1);
+}
+
+BOOST_AUTO_TEST_CASE(publish)
+{
+    int firstFlag = 0, secondFlag = 0;
+    TSnapshotLazy<int> lazy([&firstFlag](){ return (++firstFlag, 1); });
+    lazy.Publish([&secondFlag](){ return (++secondFlag, 2); });
+    BOOST_REQUIRE_EQUAL(secondFlag, 0);
+    BOOST_REQUIRE_EQUAL(lazy.Snapshot(), 2);
+    BOOST_REQUIRE_EQUAL(firstFlag, 0);
+    BOOST_REQUIRE_EQUAL(secondFlag, 1);
+    lazy = 3;
+    BOOST_REQUIRE_EQUAL(lazy.Snapshot(), 3);
+    BOOST_REQUIRE_EQUAL(secondFlag, 1);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_isolation)
+{
+    TSnapshotLazy<std::vector<int>> lazy(
+        [](){ return std::vector<int>(3, 1); });
+    TSnapshot<std::vector<int>> snapshot(lazy.Snapshot());
+    lazy = std::vector<int>(5, 2);
+    BOOST_REQUIRE_EQUAL(snapshot->size(), 3u);
+    BOOST_REQUIRE_EQUAL(lazy.Snapshot()->size(), 5u);
+    TSnapshot<std::vector<int>> moved(std::move(snapshot));
+    lazy = std::vector<int>(7, 3);
+    BOOST_REQUIRE_EQUAL(moved->size(), 3u);
+    BOOST_REQUIRE_EQUAL((*moved)[0], 1);
+}
+
+struct TDestructionCounter
+{
+    int* Counter_;
+
+    inline explicit TDestructionCounter(int* counter)
+        : Counter_(counter)
+    {
+    }
+
+    inline ~TDestructionCounter()
+    {
+        ++*Counter_;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(reclamation)
+{
+    int counter = 0;
+    {
+        TSnapshotLazy<TDestructionCounter> lazy(
+            [&counter](){ return TDestructionCounter(&counter); });
+        BOOST_REQUIRE_EQUAL(lazy.Snapshot()->Counter_, &counter);
+        counter = 0;
+        {
+            TSnapshot<TDestructionCounter> snapshot(lazy.Snapshot());
+            lazy.Publish(
+                [&counter](){ return TDestructionCounter(&counter); });
+            BOOST_REQUIRE_EQUAL(counter, 0);
+        }
+        lazy.Publish([&counter](){ return TDestructionCounter(&counter); });
+        BOOST_REQUIRE_EQUAL(counter, 1);
+    }
+    BOOST_REQUIRE_EQUAL(counter, 1);
+}
+
+BOOST_AUTO_TEST_CASE(reclaim)
+{
+    int counter = 0;
+    TSnapshotLazy<TDestructionCounter> lazy(
+        [&counter](){ return TDestructionCounter(&counter); });
+    {
+        TSnapshot<TDestructionCounter> snapshot(lazy.Snapshot());
+        BOOST_REQUIRE_EQUAL(snapshot->Counter_, &counter);
+        counter = 0;
+        lazy.Publish([&counter](){ return TDestructionCounter(&counter); });
+        lazy.Reclaim();
+        BOOST_REQUIRE_EQUAL(counter, 0);
+    }
+    lazy.Reclaim();
+    BOOST_REQUIRE_EQUAL(counter, 1);
+    lazy.Reclaim();
+    BOOST_REQUIRE_EQUAL(counter, 1);
+}
+
+BOOST_AUTO_TEST_CASE(slot_alignment)
+{
+    uintptr_t slot = reinterpret_cast<uintptr_t>(
+        NPrivate::TEpochThread::CurrentSlot());
+    BOOST_REQUIRE_EQUAL(slot % NPrivate::CacheLineSize, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent)
+{
+    TSnapshotLazy<std::vector<int>> lazy(
+        [](){ return std::vector<int>(100, 0); });
+    std::atomic<bool> stop(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&lazy, &stop, &errors]()
+            {
+                while (!stop.load())
+                {
+                    TSnapshot<std::vector<int>> snapshot(lazy.Snapshot());
+                    for (int value: *snapshot)
+                    {
+                        if (value != snapshot->front())
+                        {
+                            ++errors;
+                        }
+                    }
+                }
+            });
+    }
+    for (int i = 1; i < 1000; ++i)
+    {
+        if (i % 2)
+        {
+            lazy = std::vector<int>(100, i);
+        }
+        else
+        {
+            lazy.Publish([i](){ return std::vector<int>(100, i); });
+        }
+    }
+    stop.store(true);
+    for (std::thread& reader: readers)
+    {
+        reader.join();
+    }
+    BOOST_REQUIRE_EQUAL(errors, 0);
+    BOOST_REQUIRE_EQUAL(lazy.Snapshot()->front(), 999);
+}
+
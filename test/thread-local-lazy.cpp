@@ -0,0 +1,112 @@
+/*
+ * thread-local-lazy.cpp    -- per-thread lazy evaluating variables tests
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <thread-local-lazy.hpp>
+using NReinventedWheels::TThreadLocalLazy;
+namespace NPrivate = NReinventedWheels::NPrivate;
+
+#define BOOST_TEST_MODULE ThreadLocalLazyTest
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(single_thread)
+{
+    int flag = 0;
+    TThreadLocalLazy<int> lazy([&flag](){ return (++flag, 5); });
+    BOOST_REQUIRE_EQUAL(flag, 0);
+    BOOST_REQUIRE_EQUAL(lazy, 5);
+    int& value = lazy;
+    ++value;
+    BOOST_REQUIRE_EQUAL(lazy, 6);
+    BOOST_REQUIRE_EQUAL(flag, 1);
+}
+
+BOOST_AUTO_TEST_CASE(multiple_threads)
+{
+    std::atomic<int> flag(0);
+    TThreadLocalLazy<int> lazy([&flag](){ return ++flag; });
+    int main = lazy;
+    std::vector<std::thread> threads;
+    std::atomic<int> errors(0);
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.emplace_back([&lazy, &errors, main]()
+            {
+                int& value = lazy;
+                uintptr_t address = reinterpret_cast<uintptr_t>(&value);
+                if (value == main || address % NPrivate::CacheLineSize)
+                {
+                    ++errors;
+                }
+                for (int j = 0; j < 100; ++j)
+                {
+                    ++static_cast<int&>(lazy);
+                }
+                if (lazy != value || &static_cast<int&>(lazy) != &value)
+                {
+                    ++errors;
+                }
+            });
+    }
+    for (std::thread& thread: threads)
+    {
+        thread.join();
+    }
+    BOOST_REQUIRE_EQUAL(errors, 0);
+    BOOST_REQUIRE_EQUAL(flag, 5);
+    BOOST_REQUIRE_EQUAL(lazy, main);
+
+    int sum = 0, count = 0;
+    lazy.ForEach([&sum, &count](int value){ sum += value; ++count; });
+    BOOST_REQUIRE_EQUAL(count, 5);
+    BOOST_REQUIRE_EQUAL(sum, 1 + 2 + 3 + 4 + 5 + 400);
+}
+
+BOOST_AUTO_TEST_CASE(destruction)
+{
+    typedef std::shared_ptr<int> TPtr;
+    TPtr value(new int(1));
+    {
+        TThreadLocalLazy<TPtr> lazy([&value](){ return value; });
+        std::thread thread([&lazy]()
+            { static_cast<void>(static_cast<TPtr&>(lazy)); });
+        thread.join();
+        BOOST_REQUIRE_EQUAL(value.use_count(), 2);
+        static_cast<void>(static_cast<TPtr&>(lazy));
+        BOOST_REQUIRE_EQUAL(value.use_count(), 3);
+    }
+    BOOST_REQUIRE_EQUAL(value.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(reuse)
+{
+    int flag = 0;
+    for (int i = 1; i <= 3; ++i)
+    {
+        TThreadLocalLazy<int> lazy([&flag, i](){ return (++flag, i); });
+        BOOST_REQUIRE_EQUAL(lazy, i);
+        BOOST_REQUIRE_EQUAL(flag, i);
+    }
+}
+
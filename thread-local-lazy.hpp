@@ -0,0 +1,227 @@
+/*
+ * thread-local-lazy.hpp    -- per-thread lazy evaluating variables
+ *
+ * Copyright (C) 2011 Dmitry Potapov <potapov.d@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __THREAD_LOCAL_LAZY_HPP_2026_10_18__
+#define __THREAD_LOCAL_LAZY_HPP_2026_10_18__
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "lazy.hpp"
+
+namespace NReinventedWheels
+{
+    namespace NPrivate
+    {
+        struct TThreadLocalEntry
+        {
+            void* Slot_;
+            uint64_t Generation_;
+        };
+
+        // assigns each TThreadLocalLazy an index in per-thread entries
+        // tables, indices are reused after object destruction, while
+        // generations are unique, so stale entries are never matched
+        class TThreadLocalRegistry
+        {
+            std::mutex Lock_;
+            std::vector<size_t> Free_;
+            size_t Size_;
+            uint64_t Generation_;
+
+            inline TThreadLocalRegistry()
+                : Size_(0)
+                , Generation_(0)
+            {
+            }
+
+        public:
+            // never destroyed, so objects with static storage duration can
+            // be destroyed in any order
+            static inline TThreadLocalRegistry& Instance()
+            {
+                static TThreadLocalRegistry* registry =
+                    new TThreadLocalRegistry;
+                return *registry;
+            }
+
+            static inline std::vector<TThreadLocalEntry>& Entries()
+            {
+                static thread_local std::vector<TThreadLocalEntry> entries;
+                return entries;
+            }
+
+            inline void Acquire(size_t& index, uint64_t& generation)
+            {
+                std::lock_guard<std::mutex> guard(Lock_);
+                if (Free_.empty())
+                {
+                    index = Size_++;
+                }
+                else
+                {
+                    index = Free_.back();
+                    Free_.pop_back();
+                }
+                generation = ++Generation_;
+            }
+
+            inline void Release(size_t index)
+            {
+                std::lock_guard<std::mutex> guard(Lock_);
+                Free_.push_back(index);
+            }
+        };
+    }
+
+    // Lazy evaluating variable, which value is calculated separately for each
+    // thread accessing it. Values of all threads are owned by the variable
+    // and destroyed along with it, even if threads are still running.
+    // Calculator can be called concurrently from different threads.
+    template <class TValue>
+    class TThreadLocalLazy
+    {
+        typedef std::function<TValue(void)> TCalculator;
+
+        // values of different threads are kept on different cache lines
+        struct alignas(NPrivate::CacheLineSize) TSlot
+        {
+            TValue Value_;
+            TSlot* Next_;
+
+            inline explicit TSlot(const TCalculator& calculator)
+                : Value_(calculator())
+                , Next_(nullptr)
+            {
+            }
+        };
+
+        const TCalculator Calculator_;
+        size_t Index_;
+        uint64_t Generation_;
+        mutable std::mutex Lock_;
+        mutable TSlot* Slots_;
+
+        TThreadLocalLazy(const TThreadLocalLazy&) = delete;
+        TThreadLocalLazy& operator = (const TThreadLocalLazy&) = delete;
+
+        inline void Register()
+        {
+            NPrivate::TThreadLocalRegistry::Instance().Acquire(Index_,
+                Generation_);
+        }
+
+        inline TSlot* CreateSlot() const
+        {
+            std::unique_ptr<TSlot> slot(new TSlot(Calculator_));
+            std::vector<NPrivate::TThreadLocalEntry>& entries =
+                NPrivate::TThreadLocalRegistry::Entries();
+            if (entries.size() <= Index_)
+            {
+                entries.resize(Index_ + 1,
+                    NPrivate::TThreadLocalEntry{nullptr, 0});
+            }
+            std::lock_guard<std::mutex> guard(Lock_);
+            slot->Next_ = Slots_;
+            Slots_ = slot.release();
+            entries[Index_] = NPrivate::TThreadLocalEntry{Slots_, Generation_};
+            return Slots_;
+        }
+
+        inline TSlot* Slot() const
+        {
+            const std::vector<NPrivate::TThreadLocalEntry>& entries =
+                NPrivate::TThreadLocalRegistry::Entries();
+            if (Index_ < entries.size() &&
+                entries[Index_].Generation_ == Generation_)
+            {
+                return static_cast<TSlot*>(entries[Index_].Slot_);
+            }
+            return CreateSlot();
+        }
+
+    public:
+        inline explicit TThreadLocalLazy(const TCalculator& calculator)
+            : Calculator_(calculator)
+            , Slots_(nullptr)
+        {
+            Register();
+        }
+
+        inline explicit TThreadLocalLazy(TCalculator&& calculator)
+            : Calculator_(std::move(calculator))
+            , Slots_(nullptr)
+        {
+            Register();
+        }
+
+        // no thread should access variable during destruction
+        inline ~TThreadLocalLazy()
+        {
+            while (Slots_)
+            {
+                TSlot* next = Slots_->Next_;
+                delete Slots_;
+                Slots_ = next;
+            }
+            NPrivate::TThreadLocalRegistry::Instance().Release(Index_);
+        }
+
+        inline operator TValue&()
+        {
+            return Slot()->Value_;
+        }
+
+        inline operator const TValue&() const
+        {
+            return Slot()->Value_;
+        }
+
+        // Calls func for values of all threads, which accessed variable
+        // before. Values can be modified by their threads concurrently, so
+        // func should synchronize access itself.
+        template <class TFunc>
+        inline void ForEach(TFunc func)
+        {
+            std::lock_guard<std::mutex> guard(Lock_);
+            for (TSlot* slot = Slots_; slot; slot = slot->Next_)
+            {
+                func(slot->Value_);
+            }
+        }
+
+        template <class TFunc>
+        inline void ForEach(TFunc func) const
+        {
+            std::lock_guard<std::mutex> guard(Lock_);
+            for (const TSlot* slot = Slots_; slot; slot = slot->Next_)
+            {
+                func(slot->Value_);
+            }
+        }
+    };
+}
+
+#endif
+